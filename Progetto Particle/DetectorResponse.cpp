@@ -0,0 +1,77 @@
+#include "DetectorResponse.h"
+#include "TRandom3.h"
+#include <cmath>
+
+DetectorResponse::DetectorResponse(unsigned int seed): fResA(0), fResB(0), fSinhEtaMax(HUGE_VAL), fPtMin(0) {
+	for (int i = 0; i < fMaxTypes; ++i)
+		fEfficiency[i] = 1;
+	fRandom = new TRandom3(seed);
+}
+
+DetectorResponse::~DetectorResponse() {
+	delete fRandom;
+}
+
+void DetectorResponse::SetResolution(double a, double b) {
+	fResA = a;
+	fResB = b;
+}
+
+void DetectorResponse::SetAcceptance(double etaMax, double ptMin) {
+	// |eta| < etaMax  <=>  |pz| < pt * sinh(etaMax), no logarithm per track
+	fSinhEtaMax = sinh(etaMax);
+	fPtMin = ptMin;
+}
+
+void DetectorResponse::SetEfficiency(int index, double eff) {
+	if (index >= 0 && index < fMaxTypes)
+		fEfficiency[index] = eff;
+}
+
+// Copies the accepted particles of in[0, n) to out, smeared, and returns
+// how many were kept; kept[k], if given, is the position in `in` of out[k].
+// out may not overlap in and must have room for n particles.
+int DetectorResponse::Apply(const Particle* in, int n, Particle* out, int* kept) {
+	double px[fBatchSize], py[fBatchSize], pz[fBatchSize];
+	double eff[fBatchSize], gaus[fBatchSize], flat[fBatchSize], scale[fBatchSize];
+	double accept[fBatchSize];	// 0 or 1, same width as the data so SSE2 is enough
+
+	int nOut = 0;
+	for (int start = 0; start < n; start += fBatchSize) {
+		int m = n - start < fBatchSize ? n - start : fBatchSize;
+
+		for (int k = 0; k < m; ++k) {
+			const Particle& p = in[start + k];
+			px[k] = p.GetPx();
+			py[k] = p.GetPy();
+			pz[k] = p.GetPz();
+			int index = p.GetIndex();
+			eff[k] = index >= 0 && index < fMaxTypes ? fEfficiency[index] : 1.;
+		}
+
+		// random numbers first, the generator does not vectorize
+		for (int k = 0; k < m; ++k)
+			gaus[k] = fRandom->Gaus();
+		fRandom->RndmArray(m, flat);
+
+		// branch free, vectorized with -O3 -fno-math-errno;
+		// scaling keeps the direction, so eta is cut on the generated momentum
+		for (int k = 0; k < m; ++k) {
+			double pt = sqrt(px[k] * px[k] + py[k] * py[k]);
+			double sigma = sqrt(fResA * fResA + fResB * fResB * pt * pt);
+			double s = 1. + sigma * gaus[k];
+			double ptS = pt * s;
+			scale[k] = s;
+			accept[k] = (s > 0) & (ptS >= fPtMin) & (fabs(pz[k]) < pt * fSinhEtaMax) & (flat[k] < eff[k]) ? 1. : 0.;
+		}
+
+		// compaction: every particle is written, only accepted ones advance nOut
+		for (int k = 0; k < m; ++k) {
+			out[nOut] = in[start + k];
+			out[nOut].SetP(px[k] * scale[k], py[k] * scale[k], pz[k] * scale[k]);
+			if (kept) kept[nOut] = start + k;
+			nOut += int(accept[k]);
+		}
+	}
+	return nOut;
+}
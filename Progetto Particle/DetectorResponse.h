@@ -0,0 +1,41 @@
+#ifndef DETECTORRESPONSE_H
+#define DETECTORRESPONSE_H
+
+#include "Particle.h"
+
+class TRandom;
+
+// Detector response applied to whole events between generation and pairing:
+// momentum smearing with sigma(pt)/pt = a (+) b*pt at fixed direction,
+// pt and |eta| acceptance and per-species tracking efficiency.
+// Particles are processed in batches laid out as plain arrays and rejected
+// tracks are dropped by compaction. The smearing loop is branch free but
+// vectorizes only if sqrt need not set errno, so build with
+//   g++ -O3 -fno-math-errno main.cpp Particle.cpp ParticleTypes.cpp DetectorResponse.cpp `root-config --cflags --libs`
+// (or -ffast-math); with plain -O2 the same code runs as a scalar loop.
+class DetectorResponse {
+public:
+	DetectorResponse(unsigned int seed = 0);
+	~DetectorResponse();
+
+	// owns its generator
+	DetectorResponse(const DetectorResponse&) = delete;
+	DetectorResponse& operator=(const DetectorResponse&) = delete;
+
+	void SetResolution(double a, double b);
+	void SetAcceptance(double etaMax, double ptMin);
+	void SetEfficiency(int index, double eff);
+
+	int Apply(const Particle* in, int n, Particle* out, int* kept = 0);
+
+private:
+	static const int fBatchSize = 64;
+	static const int fMaxTypes = 10;
+
+	double fResA, fResB;
+	double fSinhEtaMax, fPtMin;
+	double fEfficiency[fMaxTypes];
+	TRandom* fRandom;	// own stream, independent of gRandom
+};
+
+#endif
@@ -12,12 +12,12 @@
 ParticleType* Particle::fParticleType[fMaxNumParticleType];
 int Particle::fNParticleType = 0;
 
-Particle::Particle(const char* name, double Px = 0., double Py = 0., double Pz = 0.): fPx(Px), fPy(Py), fPz(Pz) {
+Particle::Particle(const char* name, double Px = 0., double Py = 0., double Pz = 0.): fPx(Px), fPy(Py), fPz(Pz), fWeight(1) {
 	fIndex = FindParticle(name);
 	if (fIndex == -1)
 		std::cout << "Error! There is no such Particle named " << name << std::endl;
 }
-Particle::Particle(): fIndex (-1), fPx(0), fPy(0), fPz(0){}
+Particle::Particle(): fIndex (-1), fPx(0), fPy(0), fPz(0), fWeight(1){}
 
 int Particle::FindParticle(const char* parname) {
 	for (int i = 0; i < fNParticleType; ++i) {
@@ -50,6 +50,9 @@ double Particle::GetPy() const {
 double Particle::GetPz() const {
 	return fPz;
 }
+double Particle::GetWeight() const {
+	return fWeight;
+}
 
 void Particle::AddParticleType(const char* aname, double amass, int ach, double awi) {
 	if (FindParticle(aname) == -1) {
@@ -75,6 +78,10 @@ void Particle::SetP(double px, double py, double pz) {
 	fPz = pz;
 }
 
+void Particle::SetWeight(double w) {
+	fWeight = w;
+}
+
 void Particle::PrintParticleTypes() {
 	for (int i = 0; i < fNParticleType; ++i) {	
 		std::cout << "Particle " << i << ":\n";
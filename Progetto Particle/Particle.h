@@ -15,12 +15,14 @@ public:
 	double GetPx() const;
 	double GetPy() const;
 	double GetPz() const;
+	double GetWeight() const;
 
 	static void AddParticleType(const char* aname, double amass, int ach, double awi = 0);
 	
 	void SetIndex(int i);
 	void SetIndex(const char* name);
 	void SetP(double px, double py, double pz);
+	void SetWeight(double w);
 	
 	static void PrintParticleTypes();
 	void Print() const;
@@ -36,6 +38,7 @@ private:
 
 	int fIndex;
 	double fPx, fPy, fPz;
+	double fWeight;		// importance-sampling weight, 1 for unbiased generation
 
 	static int FindParticle(const char* parname);
 
@@ -0,0 +1,296 @@
+#include "Publisher.h"
+#include "TH1.h"
+#include "TH1D.h"
+#include <iostream>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Segment layout: header, one descriptor per histogram, then the bin
+// contents of every histogram (underflow and overflow included).
+struct PublishedHeader {
+	char magic[4];
+	UInt_t nHists;
+	std::atomic<ULong64_t> version;		// odd while the publisher is copying
+	std::atomic<Int_t> stop;			// set by a reader to end the generation
+	std::atomic<Int_t> finished;		// set by the publisher after the last event
+	Long64_t nEvents;
+	Long64_t pid;						// generator process, to notice if it dies
+};
+
+struct PublishedHist {
+	char name[64];
+	Int_t nBins;
+	Int_t pad;
+	Double_t xMin, xMax, entries;
+};
+
+namespace {
+
+const char kMagic[4] = { 'H', 'P', 'U', 'B' };
+
+PublishedHist* Descriptors(PublishedHeader* header) {
+	return reinterpret_cast<PublishedHist*>(header + 1);
+}
+
+Double_t* Contents(PublishedHeader* header) {
+	return reinterpret_cast<Double_t*>(Descriptors(header) + header->nHists);
+}
+
+}
+
+HistPublisher::HistPublisher(const char* name): fName(name), fHeader(0), fSize(0) {}
+
+HistPublisher::~HistPublisher() {
+	if (fHeader) {
+		munmap(fHeader, fSize);
+		shm_unlink(fName.c_str());
+	}
+}
+
+void HistPublisher::Add(TH1* h) {
+	if (fHeader) {
+		std::cout << "Error! Cannot add " << h->GetName() << " after the first Publish" << std::endl;
+		return;
+	}
+	fHists.push_back(h);
+}
+
+Bool_t HistPublisher::Open() {
+	fSize = sizeof(PublishedHeader) + fHists.size() * sizeof(PublishedHist);
+	for (TH1* h : fHists)
+		fSize += (h->GetNbinsX() + 2) * sizeof(Double_t);
+
+	// start from a fresh segment, a crashed run may have left one behind
+	shm_unlink(fName.c_str());
+	int fd = shm_open(fName.c_str(), O_CREAT | O_RDWR, 0644);
+	if (fd < 0 || ftruncate(fd, fSize) != 0) {
+		std::cout << "Error! Cannot create shared memory segment " << fName << std::endl;
+		if (fd >= 0) close(fd);
+		return false;
+	}
+	void* map = mmap(0, fSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		std::cout << "Error! Cannot map shared memory segment " << fName << std::endl;
+		return false;
+	}
+
+	PublishedHeader* header = new (map) PublishedHeader;
+	header->nHists = fHists.size();
+	header->version.store(0);
+	header->stop.store(0);
+	header->finished.store(0);
+	header->nEvents = 0;
+	header->pid = getpid();
+	for (size_t i = 0; i < fHists.size(); ++i) {
+		PublishedHist& d = Descriptors(header)[i];
+		strncpy(d.name, fHists[i]->GetName(), sizeof(d.name) - 1);
+		d.name[sizeof(d.name) - 1] = 0;
+		d.nBins = fHists[i]->GetNbinsX();
+		d.xMin = fHists[i]->GetXaxis()->GetXmin();
+		d.xMax = fHists[i]->GetXaxis()->GetXmax();
+		d.entries = 0;
+	}
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(header->magic, kMagic, 4);
+	fHeader = header;
+	return true;
+}
+
+void HistPublisher::Publish(Long64_t nEvents, Bool_t finished) {
+	if (!fHeader && !Open())
+		return;
+
+	ULong64_t v = fHeader->version.load(std::memory_order_relaxed);
+	fHeader->version.store(v + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Double_t* c = Contents(fHeader);
+	for (size_t i = 0; i < fHists.size(); ++i) {
+		Int_t nBins = fHists[i]->GetNbinsX();
+		for (Int_t bin = 0; bin < nBins + 2; ++bin)
+			*c++ = fHists[i]->GetBinContent(bin);
+		Descriptors(fHeader)[i].entries = fHists[i]->GetEntries();
+	}
+	fHeader->nEvents = nEvents;
+
+	fHeader->version.store(v + 2, std::memory_order_release);
+	if (finished)
+		fHeader->finished.store(1, std::memory_order_release);
+}
+
+Bool_t HistPublisher::StopRequested() const {
+	return fHeader && fHeader->stop.load(std::memory_order_relaxed);
+}
+
+//Hist Subscriber
+
+HistSubscriber::HistSubscriber(const char* name): fName(name), fHeader(0), fSize(0), fDevice(0), fInode(0),
+	fVersion(0), fNEvents(0), fFinished(false) {}
+
+HistSubscriber::~HistSubscriber() {
+	Close();
+}
+
+void HistSubscriber::Close() {
+	if (fHeader)
+		munmap(fHeader, fSize);
+	for (TH1D* h : fHists)
+		delete h;
+	fHists.clear();
+	fHeader = 0;
+	fSize = 0;
+	fVersion = 0;
+	fNEvents = 0;
+	fFinished = false;
+}
+
+// A new generator unlinks the segment and creates another one under the
+// same name. An unlinked segment with no replacement is kept: its last
+// snapshot is still readable.
+Bool_t HistSubscriber::Replaced() const {
+	int fd = shm_open(fName.c_str(), O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	bool replaced = fstat(fd, &st) == 0 && (ULong64_t(st.st_dev) != fDevice || ULong64_t(st.st_ino) != fInode);
+	close(fd);
+	return replaced;
+}
+
+Bool_t HistSubscriber::IsOpen() {
+	if (fHeader)
+		return true;
+
+	int fd = shm_open(fName.c_str(), O_RDWR, 0);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	void* map = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && ULong64_t(st.st_size) > sizeof(PublishedHeader))
+		map = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return false;
+
+	PublishedHeader* header = static_cast<PublishedHeader*>(map);
+	if (memcmp(header->magic, kMagic, 4) != 0) {	// publisher still setting up
+		munmap(map, st.st_size);
+		return false;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	// the descriptors and all the bin arrays must fit in the segment
+	ULong64_t size = st.st_size;
+	ULong64_t needed = sizeof(PublishedHeader);
+	bool valid = header->nHists <= (size - needed) / sizeof(PublishedHist);
+	if (valid) {
+		needed += header->nHists * sizeof(PublishedHist);
+		for (UInt_t i = 0; valid && i < header->nHists; ++i) {
+			const PublishedHist& d = Descriptors(header)[i];
+			valid = d.nBins >= 0 && memchr(d.name, 0, sizeof(d.name)) != 0;
+			needed += (ULong64_t(d.nBins) + 2) * sizeof(Double_t);
+			valid = valid && needed <= size;
+		}
+	}
+	if (!valid) {
+		std::cout << "Error! Shared memory segment " << fName << " is corrupt" << std::endl;
+		munmap(map, st.st_size);
+		return false;
+	}
+	fHeader = header;
+	fSize = st.st_size;
+	fDevice = st.st_dev;
+	fInode = st.st_ino;
+
+	for (UInt_t i = 0; i < fHeader->nHists; ++i) {
+		const PublishedHist& d = Descriptors(fHeader)[i];
+		TH1D* h = new TH1D(d.name, d.name, d.nBins, d.xMin, d.xMax);
+		h->SetDirectory(0);
+		fHists.push_back(h);
+	}
+	return true;
+}
+
+Bool_t HistSubscriber::Update() {
+	if (fHeader && Replaced())
+		Close();
+	if (!IsOpen())
+		return false;
+
+	std::vector<Double_t> contents;
+	std::vector<Double_t> entries(fHists.size());
+	for (int attempt = 0; attempt < 1000; ++attempt) {
+		ULong64_t v1 = fHeader->version.load(std::memory_order_acquire);
+		if (v1 & 1) {
+			std::this_thread::yield();
+			continue;
+		}
+		if (v1 == fVersion) {
+			fFinished = fHeader->finished.load(std::memory_order_acquire);
+			return false;
+		}
+
+		const Double_t* c = Contents(fHeader);
+		contents.assign(c, reinterpret_cast<const Double_t*>(reinterpret_cast<const char*>(fHeader) + fSize));
+		for (size_t i = 0; i < fHists.size(); ++i)
+			entries[i] = Descriptors(fHeader)[i].entries;
+		Long64_t nEvents = fHeader->nEvents;
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (fHeader->version.load(std::memory_order_relaxed) != v1)
+			continue;
+
+		const Double_t* p = contents.data();
+		for (size_t i = 0; i < fHists.size(); ++i) {
+			Int_t nBins = fHists[i]->GetNbinsX();
+			for (Int_t bin = 0; bin < nBins + 2; ++bin)
+				fHists[i]->SetBinContent(bin, *p++);
+			fHists[i]->SetEntries(entries[i]);
+		}
+		fVersion = v1;
+		fNEvents = nEvents;
+		fFinished = fHeader->finished.load(std::memory_order_acquire) && fHeader->version.load(std::memory_order_relaxed) == v1;
+		return true;
+	}
+	return false;
+}
+
+TH1D* HistSubscriber::Get(const char* name) const {
+	for (TH1D* h : fHists)
+		if (strcmp(h->GetName(), name) == 0)
+			return h;
+	return 0;
+}
+
+ULong64_t HistSubscriber::GetVersion() const {
+	return fVersion;
+}
+Long64_t HistSubscriber::GetNEvents() const {
+	return fNEvents;
+}
+Bool_t HistSubscriber::IsFinished() const {
+	return fFinished;
+}
+
+// True only when attached and the generator process is gone, typically
+// killed or crashed before publishing its last snapshot
+Bool_t HistSubscriber::GeneratorExited() const {
+	if (!fHeader)
+		return false;
+	pid_t pid = fHeader->pid;
+	return pid > 0 && kill(pid, 0) != 0 && errno == ESRCH;
+}
+
+void HistSubscriber::RequestStop() {
+	if (fHeader)
+		fHeader->stop.store(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,63 @@
+#ifndef PUBLISHER_H
+#define PUBLISHER_H
+
+#include "Rtypes.h"
+#include <string>
+#include <vector>
+
+class TH1;
+class TH1D;
+struct PublishedHeader;
+
+// Periodic publishing of 1D histograms through a POSIX shared memory
+// segment. The generator keeps filling its own histograms and only copies
+// them out in Publish(); readers take consistent copies by checking the
+// segment version before and after reading (seqlock), so nobody ever
+// waits on a lock.
+class HistPublisher {
+public:
+	HistPublisher(const char* name);
+	~HistPublisher();
+
+	void Add(TH1* h);
+	void Publish(Long64_t nEvents, Bool_t finished = false);
+	Bool_t StopRequested() const;
+
+private:
+	std::string fName;
+	std::vector<TH1*> fHists;
+	PublishedHeader* fHeader;
+	ULong64_t fSize;
+
+	Bool_t Open();
+};
+
+class HistSubscriber {
+public:
+	HistSubscriber(const char* name);
+	~HistSubscriber();
+
+	Bool_t IsOpen();
+	Bool_t Update();
+	TH1D* Get(const char* name) const;
+	ULong64_t GetVersion() const;
+	Long64_t GetNEvents() const;
+	Bool_t IsFinished() const;
+	Bool_t GeneratorExited() const;
+	void RequestStop();
+
+private:
+	std::string fName;
+	PublishedHeader* fHeader;
+	ULong64_t fSize;
+	ULong64_t fDevice, fInode;	// identity of the attached segment
+	ULong64_t fVersion;
+	Long64_t fNEvents;
+	Bool_t fFinished;
+	std::vector<TH1D*> fHists;
+
+	void Close();
+	Bool_t Replaced() const;
+};
+
+#endif
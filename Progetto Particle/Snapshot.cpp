@@ -0,0 +1,294 @@
+#include "Snapshot.h"
+#include "TH1.h"
+#include "TH1D.h"
+#include "TF1.h"
+#include "TList.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// File layout: "SNAP", version, then records. Every record starts with
+// its type and its length in bytes and is padded to a multiple of 8.
+//   histogram: nBins, xMin, xMax, entries, contents, errors, name, title
+//   function:  nPar, xMin, xMax, chi2, ndf, params, errors, name, formula, owner
+// Strings are stored as length (NUL included) followed by the characters.
+
+namespace {
+
+const char kMagic[4] = { 'S', 'N', 'A', 'P' };
+const UInt_t kVersion = 1;
+const UInt_t kHist = 1;
+const UInt_t kFunc = 2;
+
+template <class T> void Append(std::vector<char>& buf, const T& v) {
+	const char* p = reinterpret_cast<const char*>(&v);
+	buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+}
+
+SnapshotWriter::SnapshotWriter(const char* filename): fFileName(filename ? filename : ""), fClosed(false) {
+	fBuffer.insert(fBuffer.end(), kMagic, kMagic + 4);
+	Append(fBuffer, kVersion);
+}
+
+SnapshotWriter::~SnapshotWriter() {
+	if (!fClosed)
+		Close();
+}
+
+void SnapshotWriter::Pad() {
+	while (fBuffer.size() % 8)
+		fBuffer.push_back(0);
+}
+
+void SnapshotWriter::PutString(const char* s) {
+	UInt_t length = strlen(s) + 1;
+	Append(fBuffer, length);
+	fBuffer.insert(fBuffer.end(), s, s + length);
+	Pad();
+}
+
+void SnapshotWriter::PutDoubles(const Double_t* v, Int_t n) {
+	const char* p = reinterpret_cast<const char*>(v);
+	fBuffer.insert(fBuffer.end(), p, p + n * sizeof(Double_t));
+}
+
+void SnapshotWriter::Add(const TH1* h) {
+	Int_t nBins = h->GetNbinsX();
+	std::vector<Double_t> contents(nBins + 2), errors(nBins + 2);
+	for (Int_t i = 0; i < nBins + 2; ++i) {
+		contents[i] = h->GetBinContent(i);
+		errors[i] = h->GetBinError(i);
+	}
+
+	size_t start = fBuffer.size();
+	Append(fBuffer, kHist);
+	Append(fBuffer, UInt_t(0));
+	Append(fBuffer, nBins);
+	Append(fBuffer, Int_t(0));
+	Append(fBuffer, h->GetXaxis()->GetXmin());
+	Append(fBuffer, h->GetXaxis()->GetXmax());
+	Append(fBuffer, h->GetEntries());
+	PutDoubles(contents.data(), nBins + 2);
+	PutDoubles(errors.data(), nBins + 2);
+	PutString(h->GetName());
+	PutString(h->GetTitle());
+	UInt_t length = fBuffer.size() - start;
+	memcpy(&fBuffer[start + 4], &length, sizeof(length));
+
+	// fit results travel with the histogram they belong to
+	TIter next(h->GetListOfFunctions());
+	while (TObject* obj = next())
+		if (obj->InheritsFrom(TF1::Class()))
+			Add(static_cast<TF1*>(obj), h->GetName());
+}
+
+void SnapshotWriter::Add(const TF1* f, const char* owner) {
+	Int_t nPar = f->GetNpar();
+
+	size_t start = fBuffer.size();
+	Append(fBuffer, kFunc);
+	Append(fBuffer, UInt_t(0));
+	Append(fBuffer, nPar);
+	Append(fBuffer, Int_t(0));
+	Append(fBuffer, f->GetXmin());
+	Append(fBuffer, f->GetXmax());
+	Append(fBuffer, f->GetChisquare());
+	Append(fBuffer, Double_t(f->GetNDF()));
+	PutDoubles(f->GetParameters(), nPar);
+	PutDoubles(f->GetParErrors(), nPar);
+	PutString(f->GetName());
+	PutString(f->GetExpFormula().Data());
+	PutString(owner);
+	UInt_t length = fBuffer.size() - start;
+	memcpy(&fBuffer[start + 4], &length, sizeof(length));
+}
+
+Bool_t SnapshotWriter::Close() {
+	fClosed = true;
+	std::ofstream out(fFileName.c_str(), std::ios::binary);
+	out.write(fBuffer.data(), fBuffer.size());
+	if (!out) {
+		std::cout << "Error! Cannot write snapshot " << fFileName << std::endl;
+		return false;
+	}
+	return true;
+}
+
+//Snapshot Reader
+
+SnapshotReader::SnapshotReader(const char* filename): fData(0), fSize(0) {
+#ifndef _WIN32
+	int fd = open(filename, O_RDONLY);
+	struct stat st;
+	if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+		void* map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			fData = static_cast<const char*>(map);
+			fSize = st.st_size;
+		}
+	}
+	if (fd >= 0)
+		close(fd);
+#endif
+	if (!fData) {
+		std::ifstream in(filename, std::ios::binary);
+		fCopy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		fData = fCopy.empty() ? 0 : fCopy.data();
+		fSize = fCopy.size();
+	}
+
+	if (!fData || !Index()) {
+		std::cout << "Error! " << filename << " is not a valid snapshot" << std::endl;
+		fHists.clear();
+		fFuncs.clear();
+	}
+}
+
+SnapshotReader::~SnapshotReader() {
+#ifndef _WIN32
+	if (fData && fCopy.empty())
+		munmap(const_cast<char*>(fData), fSize);
+#endif
+}
+
+Bool_t SnapshotReader::Index() {
+	if (fSize < 8 || memcmp(fData, kMagic, 4) != 0)
+		return false;
+	UInt_t version;
+	memcpy(&version, fData + 4, sizeof(version));
+	if (version != kVersion)
+		return false;
+
+	Long64_t pos = 8;
+	while (pos < fSize) {
+		// every record is a whole number of 8-byte words, with 16 of header
+		if (pos + 16 > fSize)
+			return false;
+		const char* rec = fData + pos;
+		UInt_t length = reinterpret_cast<const UInt_t*>(rec)[1];
+		if (length < 16 || length % 8 != 0 || length > fSize - pos)
+			return false;
+		const char* end = rec + length;
+		Int_t n = reinterpret_cast<const Int_t*>(rec)[2];
+		const Double_t* d = reinterpret_cast<const Double_t*>(rec + 16);
+		// doubles the record has room for, checked before any of them is read
+		Long64_t nDoubles = (end - (rec + 16)) / 8;
+
+		// strings follow the doubles: length, characters, padding
+		auto next = [end](const char*& p) -> const char* {
+			if (p + 4 > end) return 0;
+			UInt_t length = *reinterpret_cast<const UInt_t*>(p);
+			const char* s = p + 4;
+			if (length == 0 || s + length > end || s[length - 1] != 0) return 0;
+			p = s + ((4 + length + 7) / 8 * 8 - 4);
+			return s;
+		};
+
+		UInt_t type = reinterpret_cast<const UInt_t*>(rec)[0];
+		if (type == kHist) {
+			if (n < 0 || 3 + 2 * (Long64_t(n) + 2) > nDoubles)
+				return false;
+			SnapshotHist h;
+			h.nBins = n;
+			h.xMin = d[0];
+			h.xMax = d[1];
+			h.entries = d[2];
+			h.contents = d + 3;
+			h.errors = d + 3 + (n + 2);
+			const char* p = reinterpret_cast<const char*>(d + 3 + 2 * (n + 2));
+			if (!(h.name = next(p)) || !(h.title = next(p)))
+				return false;
+			fHists.push_back(h);
+		}
+		else if (type == kFunc) {
+			if (n < 0 || 4 + 2 * Long64_t(n) > nDoubles)
+				return false;
+			SnapshotFunc f;
+			f.nPar = n;
+			f.xMin = d[0];
+			f.xMax = d[1];
+			f.chi2 = d[2];
+			f.ndf = d[3];
+			f.params = d + 4;
+			f.errors = d + 4 + n;
+			const char* p = reinterpret_cast<const char*>(d + 4 + 2 * n);
+			if (!(f.name = next(p)) || !(f.formula = next(p)) || !(f.owner = next(p)))
+				return false;
+			fFuncs.push_back(f);
+		}
+		pos = end - fData;
+	}
+	return true;
+}
+
+Bool_t SnapshotReader::IsOpen() const {
+	return !fHists.empty() || !fFuncs.empty();
+}
+Int_t SnapshotReader::GetNHists() const {
+	return fHists.size();
+}
+Int_t SnapshotReader::GetNFuncs() const {
+	return fFuncs.size();
+}
+const SnapshotHist& SnapshotReader::GetHist(Int_t i) const {
+	return fHists[i];
+}
+const SnapshotFunc& SnapshotReader::GetFunc(Int_t i) const {
+	return fFuncs[i];
+}
+
+const SnapshotHist* SnapshotReader::FindHist(const char* name) const {
+	for (const SnapshotHist& h : fHists)
+		if (strcmp(h.name, name) == 0)
+			return &h;
+	return 0;
+}
+
+const SnapshotFunc* SnapshotReader::FindFunc(const char* name, const char* owner) const {
+	for (const SnapshotFunc& f : fFuncs)
+		if (strcmp(f.name, name) == 0 && (!owner || strcmp(f.owner, owner) == 0))
+			return &f;
+	return 0;
+}
+
+TH1D* SnapshotReader::MakeHist(const char* name) const {
+	const SnapshotHist* s = FindHist(name);
+	if (!s) {
+		std::cout << "Error! There is no histogram named " << name << " in the snapshot" << std::endl;
+		return 0;
+	}
+	TH1D* h = new TH1D(s->name, s->title, s->nBins, s->xMin, s->xMax);
+	for (Int_t i = 0; i < s->nBins + 2; ++i) {
+		h->SetBinContent(i, s->contents[i]);
+		h->SetBinError(i, s->errors[i]);
+	}
+	h->SetEntries(s->entries);
+	for (const SnapshotFunc& f : fFuncs)
+		if (strcmp(f.owner, name) == 0)
+			if (TF1* fit = MakeFunc(f.name, name))
+				h->GetListOfFunctions()->Add(fit);
+	return h;
+}
+
+TF1* SnapshotReader::MakeFunc(const char* name, const char* owner) const {
+	const SnapshotFunc* s = FindFunc(name, owner);
+	if (!s || s->formula[0] == 0) {
+		std::cout << "Error! There is no function named " << name << " with a formula in the snapshot" << std::endl;
+		return 0;
+	}
+	TF1* f = new TF1(s->name, s->formula, s->xMin, s->xMax);
+	f->SetParameters(s->params);
+	f->SetParErrors(s->errors);
+	f->SetChisquare(s->chi2);
+	f->SetNDF(static_cast<Int_t>(s->ndf));
+	return f;
+}
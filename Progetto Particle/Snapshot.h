@@ -0,0 +1,80 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "Rtypes.h"
+#include <string>
+#include <vector>
+
+class TH1;
+class TH1D;
+class TF1;
+
+// Binary snapshot of fitted histograms and fit functions. Records are
+// 8-byte aligned, so the reader maps the file and hands out pointers to
+// the bin contents and parameters without copying or parsing them.
+
+struct SnapshotHist {
+	const char* name;
+	const char* title;
+	Int_t nBins;
+	Double_t xMin, xMax, entries;
+	const Double_t* contents;	// nBins + 2 values, underflow and overflow included
+	const Double_t* errors;
+};
+
+struct SnapshotFunc {
+	const char* name;
+	const char* formula;
+	const char* owner;		// histogram the function was fitted to, "" if none
+	Int_t nPar;
+	Double_t xMin, xMax, chi2, ndf;
+	const Double_t* params;
+	const Double_t* errors;
+};
+
+class SnapshotWriter {
+public:
+	SnapshotWriter(const char* filename);
+	~SnapshotWriter();
+
+	void Add(const TH1* h);
+	void Add(const TF1* f, const char* owner = "");
+	Bool_t Close();
+
+private:
+	std::string fFileName;	// own copy, the caller's string may be a temporary
+	std::vector<char> fBuffer;
+	Bool_t fClosed;
+
+	void PutString(const char* s);
+	void PutDoubles(const Double_t* v, Int_t n);
+	void Pad();
+};
+
+class SnapshotReader {
+public:
+	SnapshotReader(const char* filename);
+	~SnapshotReader();
+
+	Bool_t IsOpen() const;
+	Int_t GetNHists() const;
+	Int_t GetNFuncs() const;
+	const SnapshotHist& GetHist(Int_t i) const;
+	const SnapshotFunc& GetFunc(Int_t i) const;
+	const SnapshotHist* FindHist(const char* name) const;
+	const SnapshotFunc* FindFunc(const char* name, const char* owner = 0) const;
+
+	TH1D* MakeHist(const char* name) const;
+	TF1* MakeFunc(const char* name, const char* owner = 0) const;
+
+private:
+	const char* fData;
+	Long64_t fSize;
+	std::vector<char> fCopy;	// used where the file cannot be mapped
+	std::vector<SnapshotHist> fHists;
+	std::vector<SnapshotFunc> fFuncs;
+
+	Bool_t Index();
+};
+
+#endif
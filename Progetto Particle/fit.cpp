@@ -1,4 +1,7 @@
 
+R__LOAD_LIBRARY(Snapshot.cpp+)
+#include "Snapshot.h"
+
 void fit(){
 
 /////////////////////////////////
@@ -164,11 +167,23 @@ gStyle->SetOptStat(2210);
   gPad->SetFillColor(42);
 
   can1->Print("FirstCanvas.gif");
-  can1->Print("FirstCanvas.C");
   can1->Print("FirstCanvas.root");  
   
   can2->Print("SecondCanvas.gif");
-  can2->Print("SecondCanvas.C");
   can2->Print("SecondCanvas.root");
  
+ /////////////////////////////////
+ ////Snapshot/////////////////////
+ /////////////////////////////////
+ //histograms and fit results, reloaded by replot.cpp
+ SnapshotWriter snap("fit.snap");
+ snap.Add(hfTypes);
+ snap.Add(hfP);
+ snap.Add(hfPhi);
+ snap.Add(hfTheta);
+ snap.Add(hK1_2);
+ snap.Add(hK3_4);
+ snap.Add(h5);
+ snap.Close();
+ 
 }
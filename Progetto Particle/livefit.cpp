@@ -0,0 +1,87 @@
+R__LOAD_LIBRARY(Publisher.cpp+)
+#include "Publisher.h"
+
+// Attaches to the histograms published by gen(nEvents, publishEvery) and
+// refits the K* peak of the 1-2 subtraction at every new snapshot.
+// Generation is stopped once a converged fit, on at least minEvents
+// events, gives an error on the mass below massErrTarget. Gives up if the
+// generator dies or publishes nothing new for waitSeconds; a generator
+// started again on /lab2 is followed to its new run.
+void livefit(double massErrTarget = 1E-3, int pollMs = 500, long minEvents = 10000, double waitSeconds = 30){
+
+gROOT->SetStyle("Plain");
+gStyle->SetOptFit(1111);
+
+ HistSubscriber live("/lab2");
+ cout << "Waiting for the generator..." << endl;
+ // the segment is removed when gen() returns, so do not wait forever
+ for (double waited = 0; !live.IsOpen(); waited += pollMs / 1000.){
+   if (waited >= waitSeconds){
+     cout << "Error! No generator published /lab2 within " << waitSeconds << " s" << endl;
+     return;
+   }
+   gSystem->Sleep(pollMs);
+ }
+
+ TH1F * hK1_2 = new TH1F("hK1_2", "K* 1-2", 160, 0, 4);
+ hK1_2->SetDirectory(0);
+ hK1_2->Sumw2();
+ TF1 * fitK = new TF1("fitK", "gaus", 0.6, 1.2);
+ fitK->SetParameters(1, 0.89, 0.05);
+
+ double lastMass = 0, lastWidth = 0;
+ double idle = 0;
+ TCanvas* can = new TCanvas("canLive", "Live K* fit", 200, 100, 800, 600);
+
+ while (true){
+   if (!live.Update()){
+     if (live.IsFinished()) break;
+     if (live.GeneratorExited()){
+       cout << "Error! The generator exited without finishing, last snapshot at " << live.GetNEvents() << " events" << endl;
+       break;
+     }
+     if (idle >= waitSeconds){
+       cout << "Error! No new histograms on /lab2 for " << waitSeconds << " s" << endl;
+       break;
+     }
+     gSystem->Sleep(pollMs);
+     idle += pollMs / 1000.;
+     continue;
+   }
+   idle = 0;
+
+   /////////////////////////////////
+   ////Histogram Subtraction////////
+   /////////////////////////////////
+   hK1_2->Reset();
+   hK1_2->Add(live.Get("HistIM2"), live.Get("HistIM1"), 1, -1);
+
+   /////////////////////////////////
+   ////Fitting//////////////////////
+   /////////////////////////////////
+   TFitResultPtr fit = hK1_2->Fit(fitK, "RQS");
+   // full accurate covariance matrix, otherwise the errors are not reliable
+   bool converged = int(fit) == 0 && fit->IsValid() && fit->CovMatrixStatus() == 3;
+   double mass = fitK->GetParameter(1), massErr = fitK->GetParError(1);
+   double width = fitK->GetParameter(2), widthErr = fitK->GetParError(2);
+   cout << "Events " << live.GetNEvents()
+        << "\tmass = " << mass << " +/- " << massErr << " (shift " << mass - lastMass << ")"
+        << "\twidth = " << width << " +/- " << widthErr << " (shift " << width - lastWidth << ")"
+        << (converged ? "" : "\tfit not converged") << endl;
+   lastMass = mass;
+   lastWidth = width;
+
+   can->cd();
+   hK1_2->GetXaxis()->SetRangeUser(0, 2);
+   hK1_2->DrawCopy();
+   can->Update();
+
+   if (live.IsFinished()) break;
+   if (converged && live.GetNEvents() >= minEvents && massErr > 0 && massErr < massErrTarget){
+     cout << "Target precision reached, stopping the generator" << endl;
+     live.RequestStop();
+     break;
+   }
+ }
+
+}
@@ -1,13 +1,42 @@
 #include "Particle.h"
+#include "DetectorResponse.h"
 #include "TMath.h"
 #include "TRandom.h"
 #include "TH1.h"
 #include "TFile.h"
 #include "TCanvas.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
 
 
-int main(){
-gRandom->SetSeed();
+// Abundances of the generated species, in particle type order
+const int nTypes = 7;
+const double abundance[nTypes] = {.4, .4, .05, .05, .045, .045, .01};
+// K* decay channels: 0 -> Pi+ K-, 1 -> Pi- K+
+const double channel[2] = {.5, .5};
+
+// Importance sampling: species and K* channels are drawn with probability
+// proportional to abundance * boost and every particle carries the weight
+// true/biased probability, so weighted histograms estimate the unbiased ones.
+// All boosts equal to 1 give the plain generation with unit weights.
+// If detector is given, primaries and daughters go through it before pairing;
+// the single particle histograms stay at generator level.
+// Returns false, generating nothing, if a boost is not positive.
+bool generate(const char* fileName, int nEvents, const double* typeBoost, const double* channelBoost,
+              DetectorResponse* detector = 0){
+for (int t = 0; t < nTypes; ++t)
+  if (!(typeBoost[t] > 0)){
+    std::cout << "Error! Boost of particle type " << t << " must be positive, not " << typeBoost[t] << std::endl;
+    return false;
+  }
+for (int c = 0; c < 2; ++c)
+  if (!(channelBoost[c] > 0)){
+    std::cout << "Error! Boost of K* decay channel " << c << " must be positive, not " << channelBoost[c] << std::endl;
+    return false;
+  }
+
+TH1::SetDefaultSumw2();
 TH1D* histTypes = new TH1D("HistTypes","Particles Types Generated", 7, 0, 7);
 TH2D* histAngles = new TH2D("HistAngles", "Distribution  Angle", 100, 0, 2*TMath::Pi(), 50, 0, TMath::Pi());
 TH1D* histP = new TH1D("HistP", "Impulse", 500, 0, 5);
@@ -20,20 +49,24 @@ TH1D* histIMKPoc = new TH1D("HistIMKPoc", "Invariant Mass between K+ Pi- ", 500,
 TH1D* histIMKPsc = new TH1D("HistIMKPsc", "Invariant Mass between K+ Pi+", 500, 0, 4);
 TH1D* histIMDecay = new TH1D("HistIMDecay", "Invariant Mass between Products of Decay", 500, 0, 4);
 
+// biased cumulative probabilities and weights, computed once
+double typeCum[nTypes], typeWeight[nTypes], norm = 0;
+for (int t = 0; t < nTypes; ++t) norm += abundance[t] * typeBoost[t];
+for (int t = 0; t < nTypes; ++t){
+  typeCum[t] = (t ? typeCum[t - 1] : 0) + abundance[t] * typeBoost[t] / norm;
+  typeWeight[t] = norm / typeBoost[t];
+}
+double chNorm = channel[0] * channelBoost[0] + channel[1] * channelBoost[1];
+double chCum0 = channel[0] * channelBoost[0] / chNorm;
+double chWeight[2] = {chNorm / channelBoost[0], chNorm / channelBoost[1]};
 
-Particle::AddParticleType("Pi+", 0.13957, 1);		//index = 0  Pi+
-Particle::AddParticleType("Pi-", 0.13957, -1);			//1  Pi-
-Particle::AddParticleType("K+", 0.49367, 1);			//2  K+
-Particle::AddParticleType("K-", 0.49367, -1);			//3  K-
-Particle::AddParticleType("p+", 0.93827, 1);			//4  p+
-Particle::AddParticleType("p-", 0.93827, -1);			//5  p-
-Particle::AddParticleType("K*", 0.89166, 0, 0.050);		//6  K*
-
-
-int nEvents = 100000;
-int nPartForEvent = 110;
+// worst case: every primary is a K* and decays in two
+const int nPartForEvent = 100 + 2 * 100;
 
 Particle particle[nPartForEvent];
+int origin[nPartForEvent];	// primary a particle comes from, to weight pairs from the same decay
+Particle reco[nPartForEvent];
+int recoOrigin[nPartForEvent], kept[nPartForEvent];
 
 for (int ev = 0; ev < nEvents; ++ev){
   int count = 0;
@@ -46,16 +79,16 @@ for (int ev = 0; ev < nEvents; ++ev){
     Py = P * TMath::Sin(theta) * TMath::Sin(phi);
     Pz = P * TMath::Cos(theta);
     particle[i].SetP(Px, Py, Pz);
-    
+    origin[i] = i;
+
     double gen = gRandom->Uniform();
-    if (gen < .4)		particle[i].SetIndex(0);
-    else if (gen < .8)		particle[i].SetIndex(1);
-    else if (gen < .85)	particle[i].SetIndex(2);
-    else if (gen < .9)		particle[i].SetIndex(3);
-    else if (gen < .945)	particle[i].SetIndex(4);
-    else if (gen < .99)	particle[i].SetIndex(5);
-    else{			particle[i].SetIndex(6);
-      if(gen > .995){
+    int type = 0;
+    while (type < nTypes - 1 && gen >= typeCum[type]) ++type;
+    particle[i].SetIndex(type);
+    particle[i].SetWeight(typeWeight[type]);
+    if (type == 6){
+      int ch = gRandom->Uniform() < chCum0 ? 0 : 1;
+      if(ch == 0){
 	particle[100+count].SetIndex(0);
 	particle[101+count].SetIndex(3);
         }
@@ -63,52 +96,73 @@ for (int ev = 0; ev < nEvents; ++ev){
         particle[100+count].SetIndex(1);
 	particle[101+count].SetIndex(2);
         }
+      particle[100+count].SetWeight(typeWeight[type] * chWeight[ch]);
+      particle[101+count].SetWeight(typeWeight[type] * chWeight[ch]);
+      origin[100+count] = origin[101+count] = i;
       particle[i].Decay2body(particle[100+count], particle[101+count]);
         count+=2;
     }
-    
-    histTypes->Fill(particle[i].GetIndex());
-    histAngles->Fill(phi, theta);
-    histP->Fill(P);
-    histPt->Fill(sqrt(pow(Px,2)+pow(Py,2)));
-    histEnergy->Fill(particle[i].Energy());
-    
+
+    double w = particle[i].GetWeight();
+    histTypes->Fill(particle[i].GetIndex(), w);
+    histAngles->Fill(phi, theta, w);
+    histP->Fill(P, w);
+    histPt->Fill(sqrt(pow(Px,2)+pow(Py,2)), w);
+    histEnergy->Fill(particle[i].Energy(), w);
+
+  }
+  // detector response: accepted tracks are compacted in reco, primaries first
+  Particle* track = particle;
+  int* trackOrigin = origin;
+  int nPrim = 100, nDecay = count;
+  if (detector){
+    nPrim = detector->Apply(particle, 100, reco, kept);
+    nDecay = detector->Apply(particle + 100, count, reco + nPrim, kept + nPrim);
+    for (int k = 0; k < nPrim + nDecay; ++k)
+      recoOrigin[k] = origin[k < nPrim ? kept[k] : 100 + kept[k]];
+    track = reco;
+    trackOrigin = recoOrigin;
   }
-  for (int i = 0; i < 100 + count - 1; ++i){
-    for(int j = i + 1; j < 100 + count - 1; ++j){
-      histIMall->Fill(particle[i].InvMass(particle[j]));
-      
-      if (particle[i].GetCharge() * particle[j].GetCharge() == 1)
-        histIMsc->Fill(particle[i].InvMass(particle[j]));
-      else if(particle[i].GetCharge() * particle[j].GetCharge() == -1)
-        histIMoc->Fill(particle[i].InvMass(particle[j]));
-      
-      if((particle[i].GetIndex() == 0 &&  particle[j].GetIndex() == 3) || 
-      	 (particle[i].GetIndex() == 3 &&  particle[j].GetIndex() == 0) ||
-      	 (particle[i].GetIndex() == 1 &&  particle[j].GetIndex() == 2) ||        
-      	 (particle[i].GetIndex() == 2 &&  particle[j].GetIndex() == 1))
-      	histIMKPoc->Fill(particle[i].InvMass(particle[j]));
-      	
-      else if((particle[i].GetIndex() == 0 &&  particle[j].GetIndex() == 2) || 
-      	 (particle[i].GetIndex() == 2 &&  particle[j].GetIndex() == 0) ||
-      	 (particle[i].GetIndex() == 1 &&  particle[j].GetIndex() == 3) ||        
-      	 (particle[i].GetIndex() == 3 &&  particle[j].GetIndex() == 1))
-      	histIMKPsc->Fill(particle[i].InvMass(particle[j]));	
-      	
-     
-     
-    }  	     
+
+  for (int i = 0; i < nPrim + nDecay - 1; ++i){
+    for(int j = i + 1; j < nPrim + nDecay - 1; ++j){
+      // particles from the same decay share a single draw: j is the daughter
+      double w = trackOrigin[i] == trackOrigin[j] ? track[j].GetWeight() : track[i].GetWeight() * track[j].GetWeight();
+      histIMall->Fill(track[i].InvMass(track[j]), w);
+
+      if (track[i].GetCharge() * track[j].GetCharge() == 1)
+        histIMsc->Fill(track[i].InvMass(track[j]), w);
+      else if(track[i].GetCharge() * track[j].GetCharge() == -1)
+        histIMoc->Fill(track[i].InvMass(track[j]), w);
+
+      if((track[i].GetIndex() == 0 &&  track[j].GetIndex() == 3) ||
+      	 (track[i].GetIndex() == 3 &&  track[j].GetIndex() == 0) ||
+      	 (track[i].GetIndex() == 1 &&  track[j].GetIndex() == 2) ||
+      	 (track[i].GetIndex() == 2 &&  track[j].GetIndex() == 1))
+      	histIMKPoc->Fill(track[i].InvMass(track[j]), w);
+
+      else if((track[i].GetIndex() == 0 &&  track[j].GetIndex() == 2) ||
+      	 (track[i].GetIndex() == 2 &&  track[j].GetIndex() == 0) ||
+      	 (track[i].GetIndex() == 1 &&  track[j].GetIndex() == 3) ||
+      	 (track[i].GetIndex() == 3 &&  track[j].GetIndex() == 1))
+      	histIMKPsc->Fill(track[i].InvMass(track[j]), w);
+
+
+
+    }
   }
-  
-  for (int m  = 0; m < count; ++m){
-    for(int n = m + 1; n < count; ++n){
-      histIMDecay->Fill(particle[100 + m].InvMass(particle[100 + n]));
+
+  for (int m  = 0; m < nDecay; ++m){
+    for(int n = m + 1; n < nDecay; ++n){
+      double w = trackOrigin[nPrim + m] == trackOrigin[nPrim + n] ? track[nPrim + n].GetWeight() :
+        track[nPrim + m].GetWeight() * track[nPrim + n].GetWeight();
+      histIMDecay->Fill(track[nPrim + m].InvMass(track[nPrim + n]), w);
   }
 }
 }
 
 
-TFile* lab = new TFile("lab.root", "RECREATE");
+TFile* lab = new TFile(fileName, "RECREATE");
  histTypes->Write();
  histAngles->Write();
  histP->Write();
@@ -121,7 +175,128 @@ TFile* lab = new TFile("lab.root", "RECREATE");
  histIMKPsc->Write();
  histIMDecay->Write();
 lab->Close();
- 
+delete lab;
+
+// the histograms live in gROOT: remove them, generate() may be called again
+TH1* hists[] = {histTypes, histAngles, histP, histPt, histEnergy, histIMall, histIMsc,
+                histIMoc, histIMKPoc, histIMKPsc, histIMDecay};
+for (TH1* h : hists) delete h;
+return true;
 }
 
+// Generates the same number of events plain and with the K* boosted, then
+// compares the weighted histograms bin by bin and the K* yield of the
+// opposite - same charge K Pi subtraction. Returns 1 if they disagree.
+int checkWeights(int nEvents, double kstarBoost){
+double noBoost[nTypes] = {1, 1, 1, 1, 1, 1, 1};
+double boost[nTypes] = {1, 1, 1, 1, 1, 1, kstarBoost};
+double channelBoost[2] = {1, 1};
+if (!generate("lab_plain.root", nEvents, noBoost, channelBoost) ||
+    !generate("lab_boost.root", nEvents, boost, channelBoost))
+  return 1;
 
+TFile* plain = new TFile("lab_plain.root", "READ");
+TFile* boosted = new TFile("lab_boost.root", "READ");
+const char* names[4] = {"HistTypes", "HistIMKPoc", "HistIMKPsc", "HistIMDecay"};
+int fail = 0;
+for (int k = 0; k < 4; ++k){
+  TH1D* h1 = (TH1D*)plain->Get(names[k]);
+  TH1D* h2 = (TH1D*)boosted->Get(names[k]);
+  double p = h1->Chi2Test(h2, "WW");
+  std::cout << names[k] << ": chi2 test p-value = " << p << std::endl;
+  if (p < 0.01) fail = 1;
+}
+
+double yield[2], error[2];
+TFile* files[2] = {plain, boosted};
+for (int k = 0; k < 2; ++k){
+  TH1D* hSub = (TH1D*)((TH1D*)files[k]->Get("HistIMKPoc"))->Clone("hSub");
+  hSub->Add((TH1D*)files[k]->Get("HistIMKPsc"), -1);
+  yield[k] = hSub->IntegralAndError(hSub->FindBin(0.6), hSub->FindBin(1.2), error[k]);
+  delete hSub;
+}
+double pull = (yield[0] - yield[1]) / sqrt(error[0] * error[0] + error[1] * error[1]);
+std::cout << "K* yield: plain " << yield[0] << " +/- " << error[0]
+          << ", boosted " << yield[1] << " +/- " << error[1] << " (pull " << pull << ")" << std::endl;
+if (fabs(pull) > 3) fail = 1;
+
+plain->Close();
+boosted->Close();
+delete plain;
+delete boosted;
+std::cout << (fail ? "Weighted generation NOT compatible" : "Weighted generation compatible") << std::endl;
+return fail;
+}
+
+// Boost read from the command line, 0 if the argument is not a positive number
+double parseBoost(const char* arg){
+char* end;
+double boost = strtod(arg, &end);
+if (end == arg || *end != 0 || !(boost > 0)){
+  std::cout << "Error! Boost must be a positive number, not \"" << arg << "\"" << std::endl;
+  return 0;
+}
+return boost;
+}
+
+// main                            plain generation, lab.root
+// main <boost>                    K* generated <boost> times more often, weighted
+// main <b0> ... <b6> [<c0> <c1>]  boost of every particle type, in index order,
+//                                 and optionally of the two K* decay channels
+// main ... detector               with a typical tracker response before pairing
+//                                 (see DetectorResponse.h for the build flags)
+// main check [boost]              statistical comparison of the two modes
+int main(int argc, char** argv){
+gRandom->SetSeed();
+
+Particle::AddParticleType("Pi+", 0.13957, 1);		//index = 0  Pi+
+Particle::AddParticleType("Pi-", 0.13957, -1);			//1  Pi-
+Particle::AddParticleType("K+", 0.49367, 1);			//2  K+
+Particle::AddParticleType("K-", 0.49367, -1);			//3  K-
+Particle::AddParticleType("p+", 0.93827, 1);			//4  p+
+Particle::AddParticleType("p-", 0.93827, -1);			//5  p-
+Particle::AddParticleType("K*", 0.89166, 0, 0.050);		//6  K*
+
+if (argc > 1 && strcmp(argv[1], "check") == 0){
+  double kstarBoost = argc > 2 ? parseBoost(argv[2]) : 10.;
+  return kstarBoost > 0 ? checkWeights(20000, kstarBoost) : 1;
+}
+
+int nBoosts = argc - 1;
+bool useDetector = nBoosts > 0 && strcmp(argv[nBoosts], "detector") == 0;
+if (useDetector) --nBoosts;
+if (nBoosts != 0 && nBoosts != 1 && nBoosts != nTypes && nBoosts != nTypes + 2){
+  std::cout << "Error! Give 1 (K*), " << nTypes << " or " << nTypes + 2 << " boosts, not " << nBoosts << std::endl;
+  return 1;
+}
+double value[nTypes + 2];
+for (int k = 0; k < nBoosts; ++k)
+  if (!(value[k] = parseBoost(argv[k + 1]))) return 1;
+
+double boost[nTypes] = {1, 1, 1, 1, 1, 1, 1};
+double channelBoost[2] = {1, 1};
+if (nBoosts == 1)
+  boost[6] = value[0];
+else if (nBoosts >= nTypes){
+  for (int t = 0; t < nTypes; ++t) boost[t] = value[t];
+  if (nBoosts == nTypes + 2){
+    channelBoost[0] = value[nTypes];
+    channelBoost[1] = value[nTypes + 1];
+  }
+}
+
+if (useDetector){
+  DetectorResponse detector(4357);
+  detector.SetResolution(0.01, 0.005);	// 1% (+) 0.5% * pt
+  detector.SetAcceptance(0.9, 0.15);
+  detector.SetEfficiency(0, 0.9);
+  detector.SetEfficiency(1, 0.9);
+  detector.SetEfficiency(2, 0.85);
+  detector.SetEfficiency(3, 0.85);
+  detector.SetEfficiency(4, 0.8);
+  detector.SetEfficiency(5, 0.8);
+  detector.SetEfficiency(6, 0);		// K* is seen only through its daughters
+  return generate("lab.root", 100000, boost, channelBoost, &detector) ? 0 : 1;
+}
+return generate("lab.root", 100000, boost, channelBoost) ? 0 : 1;
+}
@@ -1,12 +1,16 @@
 #include "Particle.h"
+#include "Publisher.h"
 #include "TMath.h"
 #include "TRandom.h"
 #include "TH1.h"
 #include "TFile.h"
 #include "TCanvas.h"
+#include <iostream>
 
 
-void gen(){
+// publishEvery > 0 publishes the histograms every publishEvery events on
+// shared memory "/lab2", where livefit.cpp can fit them during the run
+void gen(int nEvents = 100000, int publishEvery = 0){
 gRandom->SetSeed();
 TH1F* histTypes = new TH1F("HistTypes","Particles Types Generated", 7, 0, 7);
 TH1F* histPhi = new TH1F("HistPhi", "Distribution  Phi", 100, 0, 2*TMath::Pi());
@@ -31,11 +35,19 @@ Particle::AddParticleType("p-", 0.93827, -1);			//5  p-
 Particle::AddParticleType("K*", 0.89166, 0, 0.050);		//6  K*
 
 
-int nEvents = 100000;
 int nPartForEvent = 120; 
 
 Particle particle[nPartForEvent];
 
+HistPublisher publisher("/lab2");
+publisher.Add(histTypes);
+publisher.Add(histIMall);
+publisher.Add(histIM1);
+publisher.Add(histIM2);
+publisher.Add(histIM3);
+publisher.Add(histIM4);
+publisher.Add(histIMDecay);
+
 for (int ev = 0; ev < nEvents; ++ev){
   int count = 0;
   for (int i = 0; i < 100; ++i){
@@ -100,7 +112,15 @@ for (int ev = 0; ev < nEvents; ++ev){
     }
   }
   
+  if (publishEvery > 0 && (ev + 1) % publishEvery == 0){
+    publisher.Publish(ev + 1);
+    if (publisher.StopRequested()){
+      std::cout << "Stop requested after " << ev + 1 << " events" << std::endl;
+      nEvents = ev + 1;
+    }
+  }
 }
+if (publishEvery > 0) publisher.Publish(nEvents, true);
 
 
 TFile* lab2 = new TFile("lab2.root", "RECREATE");
@@ -0,0 +1,33 @@
+R__LOAD_LIBRARY(Snapshot.cpp+)
+#include "Snapshot.h"
+
+void replot(const char* filename = "fit.snap"){
+
+ SnapshotReader snap(filename);
+ if (!snap.IsOpen()) return;
+
+ /////////////////////////////////
+ ////Fit Results//////////////////
+ /////////////////////////////////
+ for (int i = 0; i < snap.GetNFuncs(); ++i){
+   const SnapshotFunc& f = snap.GetFunc(i);
+   cout << f.owner << " -> " << f.name << "  chi2/ndf = " << f.chi2 << "/" << f.ndf << endl;
+   for (int p = 0; p < f.nPar; ++p)
+     cout << "\tp" << p << " = " << f.params[p] << " +/- " << f.errors[p] << endl;
+ }
+
+ /////////////////////////////////
+ ////Display//////////////////////
+ /////////////////////////////////
+ int n = snap.GetNHists();
+ TCanvas* can = new TCanvas("canSnap", filename, 200, 100, 1000, 600);
+ can->Divide((n + 1) / 2, 2);
+ for (int i = 0; i < n; ++i){
+   can->cd(i + 1);
+   gPad->SetGrid();
+   TH1D* h = snap.MakeHist(snap.GetHist(i).name);
+   h->SetDirectory(0);
+   h->Draw();
+ }
+
+}
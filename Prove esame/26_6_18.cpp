@@ -1,3 +1,6 @@
+R__LOAD_LIBRARY(Sampler.cpp+)
+#include "Sampler.h"
+
 //QUESITO 1
 
 void q1(){
@@ -56,7 +59,8 @@ void q3(){
 gRandom->SetSeed();
 TH1F* h1 = new TH1F("h1", "h1", 100, 0., 10.);
 TF1* f1 = new TF1("f1", "sin(x) + x^2", 0., 10.);
-h1->FillRandom("f1", 1E5);
+Sampler sampler(f1);
+sampler.FillRandom(h1, 1E5);
 h1->Draw();
 }
 
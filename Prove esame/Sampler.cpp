@@ -0,0 +1,193 @@
+#include "Sampler.h"
+#include "TF1.h"
+#include "TH1.h"
+#include "TRandom3.h"
+#include <iostream>
+#include <cmath>
+#include <thread>
+
+Sampler::Sampler(std::function<double(double)> f, double a, double b, double tol, int maxSegments): fIntegral(0) {
+	Build(f, a, b, tol, maxSegments);
+}
+
+Sampler::Sampler(TF1* f, double tol, int maxSegments): fIntegral(0) {
+	Build([f](double x) { return f->Eval(x); }, f->GetXmin(), f->GetXmax(), tol, maxSegments);
+}
+
+double Sampler::GetXmin() const {
+	return fX.front();
+}
+double Sampler::GetXmax() const {
+	return fX.back();
+}
+double Sampler::GetIntegral() const {
+	return fIntegral;
+}
+int Sampler::GetNSegments() const {
+	return fX.size() - 1;
+}
+
+void Sampler::Build(const std::function<double(double)>& f, double a, double b, double tol, int maxSegments) {
+	// a pdf cannot be negative: clip the function where it goes below zero
+	auto pdf = [&f](double x) { double y = f(x); return y > 0 ? y : 0.; };
+
+	// coarse uniform pass, with midpoints, for a Simpson estimate of the integral
+	const int nStart = 16;
+	double h = (b - a) / nStart;
+	std::vector<double> x0(nStart + 1), f0(nStart + 1);
+	for (int i = 0; i <= nStart; ++i) {
+		x0[i] = a + i * h;
+		f0[i] = pdf(x0[i]);
+	}
+	double estimate = 0;
+	for (int i = 0; i < nStart; ++i)
+		estimate += h / 6. * (f0[i] + 4 * pdf(x0[i] + h / 2) + f0[i + 1]);
+
+	// refine every segment until the trapezoid and Simpson areas agree;
+	// segments are kept on a stack so the nodes come out already sorted
+	struct Segment { double xl, fl, xr, fr; };
+	std::vector<Segment> stack;
+	for (int i = nStart - 1; i >= 0; --i)
+		stack.push_back({ x0[i], f0[i], x0[i + 1], f0[i + 1] });
+
+	fX.assign(1, a);
+	fF.assign(1, f0[0]);
+	while (!stack.empty()) {
+		Segment s = stack.back();
+		stack.pop_back();
+		double xm = 0.5 * (s.xl + s.xr);
+		double fm = pdf(xm);
+		double err = (s.xr - s.xl) * 2. / 3. * std::fabs(fm - 0.5 * (s.fl + s.fr));
+		int nSegments = fX.size() - 1 + stack.size() + 1;
+		if (err > tol * estimate * (s.xr - s.xl) / (b - a) && nSegments < maxSegments) {
+			stack.push_back({ xm, fm, s.xr, s.fr });
+			stack.push_back({ s.xl, s.fl, xm, fm });
+		}
+		else {
+			fX.push_back(s.xr);
+			fF.push_back(s.fr);
+		}
+	}
+
+	int n = fX.size() - 1;
+	fCdf.assign(n + 1, 0.);
+	for (int i = 0; i < n; ++i)
+		fCdf[i + 1] = fCdf[i] + 0.5 * (fX[i + 1] - fX[i]) * (fF[i] + fF[i + 1]);
+	fIntegral = fCdf[n];
+
+	if (fIntegral <= 0) {
+		std::cout << "Error! Sampler function has null integral in [" << a << ", " << b << "], using a flat pdf" << std::endl;
+		for (int i = 0; i <= n; ++i) {
+			fF[i] = 1. / (b - a);
+			fCdf[i] = (fX[i] - a) / (b - a);
+		}
+		fIntegral = 0;
+	}
+	else {
+		for (int i = 0; i <= n; ++i)
+			fCdf[i] /= fIntegral;
+	}
+	fCdf[n] = 1.;
+
+	// fGuide[k] is the first segment whose upper cdf exceeds k/n
+	fGuide.assign(n, 0);
+	int seg = 0;
+	for (int k = 0; k < n; ++k) {
+		while (seg < n - 1 && fCdf[seg + 1] <= double(k) / n)
+			++seg;
+		fGuide[k] = seg;
+	}
+}
+
+double Sampler::Invert(double u) const {
+	int n = fGuide.size();
+	int k = static_cast<int>(u * n);
+	if (k >= n) k = n - 1;
+	int i = fGuide[k];
+	while (i < n - 1 && fCdf[i + 1] <= u)
+		++i;
+
+	// pdf is linear inside the segment: solve the quadratic for the local cdf,
+	// written in the form that stays stable when the slope goes to zero
+	double h = fX[i + 1] - fX[i];
+	double area = (u - fCdf[i]) * (fIntegral > 0 ? fIntegral : 1.);
+	double slope = (fF[i + 1] - fF[i]) / h;
+	double disc = fF[i] * fF[i] + 2 * slope * area;
+	double denom = fF[i] + sqrt(disc > 0 ? disc : 0.);
+	double t = denom > 0 ? 2 * area / denom : 0.;
+	if (t > h) t = h;
+	return fX[i] + t;
+}
+
+double Sampler::Draw(TRandom* rng) const {
+	return Invert(rng->Rndm());
+}
+
+void Sampler::Draw(double* out, int n, TRandom* rng) const {
+	rng->RndmArray(n, out);
+	for (int i = 0; i < n; ++i)
+		out[i] = Invert(out[i]);
+}
+
+void Sampler::Stream(Long64_t n, std::function<void(const double*, int)> sink, TRandom* rng) const {
+	if (!rng) rng = gRandom;
+	std::vector<double> buffer(fBatchSize);
+	while (n > 0) {
+		int batch = n < fBatchSize ? n : fBatchSize;
+		Draw(buffer.data(), batch, rng);
+		sink(buffer.data(), batch);
+		n -= batch;
+	}
+}
+
+void Sampler::FillRandom(TH1* h, Long64_t n, TRandom* rng) const {
+	Stream(n, [h](const double* x, int batch) { h->FillN(batch, x, 0); }, rng);
+}
+
+void Sampler::FillRandom(TH1* h, Long64_t n, int nThreads, UInt_t seed) const {
+	if (nThreads < 2) {
+		FillRandom(h, n);
+		return;
+	}
+
+	// each thread draws from its own generator and counts into a private copy
+	// of the bins; only the final merge touches the histogram
+	int nBins = h->GetNcells();
+	std::vector<TRandom3*> rngs(nThreads);
+	for (int t = 0; t < nThreads; ++t)
+		rngs[t] = new TRandom3(seed == 0 ? 0 : seed + t);
+	std::vector<std::vector<double>> counts(nThreads, std::vector<double>(nBins, 0.));
+
+	std::vector<std::thread> threads;
+	const TAxis* axis = h->GetXaxis();
+	for (int t = 0; t < nThreads; ++t) {
+		Long64_t nThread = n / nThreads + (t < n % nThreads ? 1 : 0);
+		threads.emplace_back([this, t, nThread, axis, &rngs, &counts]() {
+			std::vector<double>& c = counts[t];
+			Stream(nThread, [axis, &c](const double* x, int batch) {
+				for (int i = 0; i < batch; ++i)
+					c[axis->FindFixBin(x[i])] += 1;
+			}, rngs[t]);
+		});
+	}
+	for (auto& th : threads)
+		th.join();
+
+	double entries = h->GetEntries();
+	bool sumw2 = h->GetSumw2N() > 0;
+	for (int t = 0; t < nThreads; ++t) {
+		for (int bin = 0; bin < nBins; ++bin) {
+			if (counts[t][bin] == 0) continue;
+			h->AddBinContent(bin, counts[t][bin]);
+			if (sumw2) h->GetSumw2()->fArray[bin] += counts[t][bin];
+		}
+		delete rngs[t];
+	}
+	h->ResetStats();
+	h->SetEntries(entries + n);
+}
+
+void Sampler::Print() const {
+	std::cout << "Sampler on [" << GetXmin() << ", " << GetXmax() << "]\n\tSegments = "
+		<< GetNSegments() << "\n\tIntegral = " << fIntegral << std::endl;
+}
@@ -0,0 +1,48 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include "Rtypes.h"
+#include <functional>
+#include <vector>
+
+class TRandom;
+class TH1;
+class TF1;
+
+// Inverse-CDF sampler built once from a non negative function on [a,b].
+// The function is approximated by a piecewise linear pdf on adaptively
+// refined nodes, so the table is exact to the requested relative
+// tolerance on the integral of every segment.
+class Sampler {
+public:
+	Sampler(std::function<double(double)> f, double a, double b, double tol = 1E-4, int maxSegments = 1 << 16);
+	Sampler(TF1* f, double tol = 1E-4, int maxSegments = 1 << 16);
+
+	double GetXmin() const;
+	double GetXmax() const;
+	double GetIntegral() const;
+	int GetNSegments() const;
+
+	double Draw(TRandom* rng) const;
+	void Draw(double* out, int n, TRandom* rng) const;
+
+	void FillRandom(TH1* h, Long64_t n, TRandom* rng = 0) const;
+	void FillRandom(TH1* h, Long64_t n, int nThreads, UInt_t seed = 0) const;
+	void Stream(Long64_t n, std::function<void(const double*, int)> sink, TRandom* rng = 0) const;
+
+	void Print() const;
+
+private:
+	static const int fBatchSize = 4096;
+
+	std::vector<double> fX;		// segment edges
+	std::vector<double> fF;		// pdf at the edges
+	std::vector<double> fCdf;	// normalized cdf at the edges
+	std::vector<int> fGuide;	// guide table for the segment search
+	double fIntegral;
+
+	void Build(const std::function<double(double)>& f, double a, double b, double tol, int maxSegments);
+	double Invert(double u) const;
+};
+
+#endif
@@ -0,0 +1,341 @@
+#include "CountHist2D.h"
+#include "TH1D.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const char kMagic[4] = { 'C', 'H', '2', 'D' };
+const UInt_t kVersion = 2;	// 2: lost counts after the outside ones
+const UInt_t kMaxCount = std::numeric_limits<UInt_t>::max();
+
+void PutVarint(std::vector<unsigned char>& buf, ULong64_t v) {
+	while (v >= 0x80) {
+		buf.push_back(static_cast<unsigned char>(v | 0x80));
+		v >>= 7;
+	}
+	buf.push_back(static_cast<unsigned char>(v));
+}
+
+ULong64_t GetVarint(const unsigned char*& p, const unsigned char* end) {
+	ULong64_t v = 0;
+	for (int shift = 0; p < end && shift < 64; shift += 7) {
+		unsigned char b = *p++;
+		v |= ULong64_t(b & 0x7f) << shift;
+		if (!(b & 0x80))
+			break;
+	}
+	return v;
+}
+
+template <class T> void Put(std::ofstream& out, const T& v) {
+	out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <class T> bool Get(std::ifstream& in, T& v) {
+	return static_cast<bool>(in.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+}
+
+CountHist2D::CountHist2D(const char* name, Int_t nx, Double_t xmin, Double_t xmax, Int_t ny, Double_t ymin, Double_t ymax, Bool_t sparse):
+	fName(name), fNx(nx), fNy(ny), fXmin(xmin), fXmax(xmax), fYmin(ymin), fYmax(ymax), fEntries(0), fOutside(0), fSaturated(0) {
+	if (!CheckSize(nx, ny)) {
+		std::cout << "Error! " << fName << ": " << nx << " x " << ny << " bins is not a valid size, histogram left empty" << std::endl;
+		fNx = fNy = 0;
+	}
+	fNBlocksX = (Long64_t(fNx) + fBlockX - 1) / fBlockX;
+	fNBlocksY = (Long64_t(fNy) + fBlockY - 1) / fBlockY;
+	fBlocks.resize(Long64_t(fNBlocksX) * fNBlocksY);
+	if (!sparse)
+		for (auto& block : fBlocks)
+			block.assign(fBlockX * fBlockY, 0);
+}
+
+Bool_t CountHist2D::CheckSize(Int_t nx, Int_t ny) {
+	if (nx < 0 || ny < 0)
+		return false;
+	return (Long64_t(nx) + fBlockX - 1) / fBlockX * ((Long64_t(ny) + fBlockY - 1) / fBlockY) <= fMaxBlocks;
+}
+
+const char* CountHist2D::GetName() const {
+	return fName.c_str();
+}
+Int_t CountHist2D::GetNbinsX() const {
+	return fNx;
+}
+Int_t CountHist2D::GetNbinsY() const {
+	return fNy;
+}
+ULong64_t CountHist2D::GetEntries() const {
+	return fEntries;
+}
+ULong64_t CountHist2D::GetNSaturated() const {
+	return fSaturated;
+}
+
+Int_t CountHist2D::GetNBlocks() const {
+	Int_t n = 0;
+	for (const auto& block : fBlocks)
+		if (!block.empty()) ++n;
+	return n;
+}
+
+Long64_t CountHist2D::GetMemorySize() const {
+	return sizeof(*this) + fBlocks.size() * sizeof(fBlocks[0]) + Long64_t(GetNBlocks()) * fBlockX * fBlockY * sizeof(UInt_t);
+}
+
+Int_t CountHist2D::FindBin(Double_t v, Int_t n, Double_t min, Double_t max) const {
+	if (!(v >= min) || v >= max)
+		return -1;
+	Int_t bin = static_cast<Int_t>((v - min) / (max - min) * n);
+	return bin < n ? bin : n - 1;
+}
+
+UInt_t* CountHist2D::Cell(Int_t ix, Int_t iy) {
+	std::vector<UInt_t>& block = fBlocks[ix / fBlockX + fNBlocksX * (iy / fBlockY)];
+	if (block.empty())
+		block.assign(fBlockX * fBlockY, 0);
+	return &block[ix % fBlockX + fBlockX * (iy % fBlockY)];
+}
+
+void CountHist2D::Saturate(ULong64_t lost) {
+	if (fSaturated == 0)
+		std::cout << "Warning! " << GetName() << ": bin content reached " << kMaxCount << ", further counts are lost" << std::endl;
+	fSaturated += lost;
+}
+
+void CountHist2D::Fill(Double_t x, Double_t y) {
+	++fEntries;
+	Int_t ix = FindBin(x, fNx, fXmin, fXmax);
+	Int_t iy = FindBin(y, fNy, fYmin, fYmax);
+	if (ix < 0 || iy < 0) {
+		++fOutside;
+		return;
+	}
+	UInt_t* cell = Cell(ix, iy);
+	if (*cell == kMaxCount) {
+		Saturate(1);
+		return;
+	}
+	++*cell;
+}
+
+ULong64_t CountHist2D::GetBinContent(Int_t binx, Int_t biny) const {
+	Int_t ix = binx - 1, iy = biny - 1;
+	if (ix < 0 || ix >= fNx || iy < 0 || iy >= fNy)
+		return 0;
+	const std::vector<UInt_t>& block = fBlocks[ix / fBlockX + fNBlocksX * (iy / fBlockY)];
+	return block.empty() ? 0 : block[ix % fBlockX + fBlockX * (iy % fBlockY)];
+}
+
+void CountHist2D::Add(const CountHist2D& other) {
+	if (other.fNx != fNx || other.fNy != fNy || other.fXmin != fXmin || other.fXmax != fXmax ||
+		other.fYmin != fYmin || other.fYmax != fYmax) {
+		std::cout << "Error! Cannot add " << other.GetName() << " to " << GetName() << ": different binning" << std::endl;
+		return;
+	}
+	for (size_t b = 0; b < fBlocks.size(); ++b) {
+		const std::vector<UInt_t>& src = other.fBlocks[b];
+		if (src.empty()) continue;
+		if (fBlocks[b].empty()) {
+			fBlocks[b] = src;
+			continue;
+		}
+		UInt_t* dst = fBlocks[b].data();
+		for (size_t i = 0; i < src.size(); ++i) {
+			ULong64_t sum = ULong64_t(dst[i]) + src[i];
+			if (sum > kMaxCount) {
+				Saturate(sum - kMaxCount);
+				sum = kMaxCount;
+			}
+			dst[i] = sum;
+		}
+	}
+	fEntries += other.fEntries;
+	fOutside += other.fOutside;
+	fSaturated += other.fSaturated;
+}
+
+TH1D* CountHist2D::ProjectionY(const char* name, Double_t xmin, Double_t xmax) const {
+	TH1D* h = new TH1D(name, fName.c_str(), fNy, fYmin, fYmax);
+	Int_t first = xmin <= fXmin ? 0 : FindBin(xmin, fNx, fXmin, fXmax);
+	Int_t last = xmax >= fXmax ? fNx - 1 : FindBin(xmax, fNx, fXmin, fXmax);
+	if (first < 0 || last < 0) return h;
+
+	std::vector<Double_t> sum(fNy, 0.);
+	for (Int_t by = 0; by < fNBlocksY; ++by) {
+		for (Int_t bx = first / fBlockX; bx <= last / fBlockX; ++bx) {
+			const std::vector<UInt_t>& block = fBlocks[bx + fNBlocksX * by];
+			if (block.empty()) continue;
+			for (Int_t j = 0; j < fBlockY && by * fBlockY + j < fNy; ++j)
+				for (Int_t i = 0; i < fBlockX; ++i) {
+					Int_t ix = bx * fBlockX + i;
+					if (ix >= first && ix <= last)
+						sum[by * fBlockY + j] += block[i + fBlockX * j];
+				}
+		}
+	}
+	Double_t total = 0;
+	for (Int_t iy = 0; iy < fNy; ++iy) {
+		h->SetBinContent(iy + 1, sum[iy]);
+		total += sum[iy];
+	}
+	h->SetEntries(total);
+	return h;
+}
+
+TH1D* CountHist2D::ProjectionX(const char* name, Double_t ymin, Double_t ymax) const {
+	TH1D* h = new TH1D(name, fName.c_str(), fNx, fXmin, fXmax);
+	Int_t first = ymin <= fYmin ? 0 : FindBin(ymin, fNy, fYmin, fYmax);
+	Int_t last = ymax >= fYmax ? fNy - 1 : FindBin(ymax, fNy, fYmin, fYmax);
+	if (first < 0 || last < 0) return h;
+
+	std::vector<Double_t> sum(fNx, 0.);
+	for (Int_t by = first / fBlockY; by <= last / fBlockY; ++by) {
+		for (Int_t bx = 0; bx < fNBlocksX; ++bx) {
+			const std::vector<UInt_t>& block = fBlocks[bx + fNBlocksX * by];
+			if (block.empty()) continue;
+			for (Int_t j = 0; j < fBlockY; ++j) {
+				Int_t iy = by * fBlockY + j;
+				if (iy < first || iy > last) continue;
+				for (Int_t i = 0; i < fBlockX && bx * fBlockX + i < fNx; ++i)
+					sum[bx * fBlockX + i] += block[i + fBlockX * j];
+			}
+		}
+	}
+	Double_t total = 0;
+	for (Int_t ix = 0; ix < fNx; ++ix) {
+		h->SetBinContent(ix + 1, sum[ix]);
+		total += sum[ix];
+	}
+	h->SetEntries(total);
+	return h;
+}
+
+// File layout: magic, version, name, binning, entries, outside and lost
+// counts (the latter from version 2), then every filled block as (index,
+// byte length, varint pairs of zero run and count).
+// Trailing zeros of a block are not stored.
+Bool_t CountHist2D::Write(const char* filename) const {
+	std::ofstream out(filename, std::ios::binary);
+	if (!out) {
+		std::cout << "Error! Cannot open " << filename << " for writing" << std::endl;
+		return false;
+	}
+	out.write(kMagic, 4);
+	Put(out, kVersion);
+	UInt_t nameLength = fName.size();
+	Put(out, nameLength);
+	out.write(fName.data(), nameLength);
+	Put(out, fNx); Put(out, fXmin); Put(out, fXmax);
+	Put(out, fNy); Put(out, fYmin); Put(out, fYmax);
+	Put(out, fEntries);
+	Put(out, fOutside);
+	Put(out, fSaturated);
+	UInt_t nBlocks = GetNBlocks();
+	Put(out, nBlocks);
+
+	std::vector<unsigned char> buf;
+	for (size_t b = 0; b < fBlocks.size(); ++b) {
+		const std::vector<UInt_t>& block = fBlocks[b];
+		if (block.empty()) continue;
+		buf.clear();
+		ULong64_t zeros = 0;
+		for (UInt_t count : block) {
+			if (count == 0) {
+				++zeros;
+				continue;
+			}
+			PutVarint(buf, zeros);
+			PutVarint(buf, count);
+			zeros = 0;
+		}
+		UInt_t index = b, length = buf.size();
+		Put(out, index);
+		Put(out, length);
+		out.write(reinterpret_cast<const char*>(buf.data()), length);
+	}
+	return static_cast<bool>(out);
+}
+
+CountHist2D* CountHist2D::Read(const char* filename) {
+	std::ifstream in(filename, std::ios::binary);
+	char magic[4];
+	UInt_t version = 0;
+	if (!in || !in.read(magic, 4) || std::memcmp(magic, kMagic, 4) != 0 || !Get(in, version) || version < 1 || version > kVersion) {
+		std::cout << "Error! " << filename << " is not a CountHist2D file" << std::endl;
+		return 0;
+	}
+	UInt_t nameLength = 0;
+	std::string name;
+	Int_t nx = 0, ny = 0;
+	Double_t xmin = 0, xmax = 0, ymin = 0, ymax = 0;
+	ULong64_t entries = 0, outside = 0, saturated = 0;
+	UInt_t nBlocks = 0;
+	bool ok = Get(in, nameLength) && nameLength < 4096;
+	if (ok) {
+		name.assign(nameLength, ' ');
+		ok = static_cast<bool>(in.read(&name[0], nameLength));
+	}
+	ok = ok && Get(in, nx) && Get(in, xmin) && Get(in, xmax) && Get(in, ny) && Get(in, ymin) && Get(in, ymax)
+		&& Get(in, entries) && Get(in, outside) && (version < 2 || Get(in, saturated)) && Get(in, nBlocks);
+	if (!ok || nx <= 0 || ny <= 0 || !CheckSize(nx, ny) || !(xmin < xmax) || !(ymin < ymax)) {
+		std::cout << "Error! " << filename << " has a corrupt header" << std::endl;
+		return 0;
+	}
+
+	CountHist2D* h = new CountHist2D(name.c_str(), nx, xmin, xmax, ny, ymin, ymax);
+	h->fEntries = entries;
+	h->fOutside = outside;
+	h->fSaturated = saturated;
+
+	// a full tile is fBlockX * fBlockY pairs of at most 2 + 5 varint bytes
+	const UInt_t maxLength = fBlockX * fBlockY * 7;
+
+	std::vector<unsigned char> buf;
+	for (UInt_t n = 0; n < nBlocks; ++n) {
+		UInt_t index = 0, length = 0;
+		if (!Get(in, index) || !Get(in, length) || index >= h->fBlocks.size() || length > maxLength) {
+			std::cout << "Error! " << filename << " is truncated or corrupt" << std::endl;
+			delete h;
+			return 0;
+		}
+		buf.resize(length);
+		if (!in.read(reinterpret_cast<char*>(buf.data()), length)) {
+			std::cout << "Error! " << filename << " is truncated" << std::endl;
+			delete h;
+			return 0;
+		}
+
+		std::vector<UInt_t>& block = h->fBlocks[index];
+		block.assign(fBlockX * fBlockY, 0);
+		const unsigned char* p = buf.data();
+		const unsigned char* end = p + length;
+		ULong64_t cell = 0;
+		while (p < end) {
+			cell += GetVarint(p, end);
+			ULong64_t count = GetVarint(p, end);
+			if (cell < block.size()) {
+				if (count > kMaxCount) {
+					h->fSaturated += count - kMaxCount;
+					count = kMaxCount;
+				}
+				block[cell] = count;
+			}
+			++cell;
+		}
+	}
+	if (h->fSaturated)
+		std::cout << "Warning! " << filename << ": " << h->fSaturated << " counts lost to saturated bins, projections are truncated" << std::endl;
+	return h;
+}
+
+void CountHist2D::Print() const {
+	std::cout << "CountHist2D " << fName << ": " << fNx << " x " << fNy << " bins"
+		<< "\n\tEntries = " << fEntries << " (" << fOutside << " outside, " << fSaturated << " lost to saturation)"
+		<< "\n\tBlocks = " << GetNBlocks() << " / " << fBlocks.size()
+		<< "\n\tMemory = " << GetMemorySize() / 1024. << " kB" << std::endl;
+}
@@ -0,0 +1,58 @@
+#ifndef COUNTHIST2D_H
+#define COUNTHIST2D_H
+
+#include "Rtypes.h"
+#include <string>
+#include <vector>
+
+class TH1D;
+
+// Integer-count 2D histogram with block storage: the grid is cut in
+// fBlockX x fBlockY tiles and a tile is only allocated at its first fill,
+// so empty regions cost nothing. Counts are exact up to 2^32 - 1 per bin;
+// fills and sums beyond that saturate the bin and are counted as lost.
+class CountHist2D {
+public:
+	CountHist2D(const char* name, Int_t nx, Double_t xmin, Double_t xmax, Int_t ny, Double_t ymin, Double_t ymax, Bool_t sparse = true);
+
+	const char* GetName() const;
+	Int_t GetNbinsX() const;
+	Int_t GetNbinsY() const;
+	ULong64_t GetEntries() const;
+	ULong64_t GetNSaturated() const;
+	ULong64_t GetBinContent(Int_t binx, Int_t biny) const;
+	Int_t GetNBlocks() const;
+	Long64_t GetMemorySize() const;
+
+	void Fill(Double_t x, Double_t y);
+	void Add(const CountHist2D& other);
+
+	TH1D* ProjectionX(const char* name, Double_t ymin, Double_t ymax) const;
+	TH1D* ProjectionY(const char* name, Double_t xmin, Double_t xmax) const;
+
+	Bool_t Write(const char* filename) const;
+	static CountHist2D* Read(const char* filename);
+
+	void Print() const;
+
+private:
+	static const Int_t fBlockX = 64;
+	static const Int_t fBlockY = 16;
+	static const Long64_t fMaxBlocks = 1 << 20;	// 2^30 bins, 24 MB of empty block table
+
+	std::string fName;
+	Int_t fNx, fNy;
+	Double_t fXmin, fXmax, fYmin, fYmax;
+	Int_t fNBlocksX, fNBlocksY;
+	ULong64_t fEntries;
+	ULong64_t fOutside;	// fills falling out of the axis ranges
+	ULong64_t fSaturated;	// counts lost to full bins
+	std::vector<std::vector<UInt_t>> fBlocks;	// empty vector = block never filled
+
+	UInt_t* Cell(Int_t ix, Int_t iy);
+	Int_t FindBin(Double_t v, Int_t n, Double_t min, Double_t max) const;
+	void Saturate(ULong64_t lost);
+	static Bool_t CheckSize(Int_t nx, Int_t ny);
+};
+
+#endif
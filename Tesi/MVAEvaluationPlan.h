@@ -0,0 +1,141 @@
+#ifndef MVAEVALUATIONPLAN_H
+#define MVAEVALUATIONPLAN_H
+
+#include <iostream>
+#include <vector>
+
+#include "TString.h"
+#include "TH1F.h"
+#include "TMVA/Reader.h"
+#include "TMVA/MethodBase.h"
+
+#include "CountHist2D.h"
+
+// List of the enabled MVA methods, resolved once to their MethodBase and
+// output histograms. Evaluate() then loops only over what is enabled and
+// calls the reader through the method pointer, with no name lookups.
+// Header only, but the BDT versus mass evaluator fills a CountHist2D, so
+// CountHist2D.cpp must be loaded first (runTMVAApp.sh does ".L CountHist2D.cpp+").
+class MVAEvaluationPlan {
+public:
+   enum EKind { kHist, kCuts, kBDTVsMass, kPDEFoam, kProba };
+
+   struct Evaluator {
+      TString name;
+      TMVA::MethodBase* method;
+      EKind kind;
+      TH1F *hist, *hist2, *hist3;
+      CountHist2D* hist2D;
+      const Float_t *origin, *mass;
+      Double_t aux;
+      Long64_t nPassed;
+   };
+
+   MVAEvaluationPlan(TMVA::Reader* reader): fReader(reader) {}
+
+   // Methods whose histogram is null are not enabled and are skipped
+   Bool_t Add(const char* methodName, TH1F* hist) {
+      if (!hist) return kFALSE;
+      return Push(methodName, kHist, hist);
+   }
+
+   // Cuts method at the given signal efficiency: counts the passing events
+   Bool_t AddCuts(const char* methodName, Double_t effS) {
+      if (!Push(methodName, kCuts, 0)) return kFALSE;
+      fEvaluators.back().aux = effS;
+      return kTRUE;
+   }
+
+   // BDT split by origin (4 prompt, 5 feed-down) and versus invariant mass
+   Bool_t AddBDTVsMass(const char* methodName, TH1F* histPrompt, TH1F* histFeedDown, CountHist2D* histVsMass,
+                       const Float_t* origin, const Float_t* mass) {
+      if (!histVsMass || !Push(methodName, kBDTVsMass, histPrompt)) return kFALSE;
+      Evaluator& e = fEvaluators.back();
+      e.hist2 = histFeedDown;
+      e.hist2D = histVsMass;
+      e.origin = origin;
+      e.mass = mass;
+      return kTRUE;
+   }
+
+   // Response, per-event error and significance
+   Bool_t AddPDEFoam(const char* methodName, TH1F* hist, TH1F* histErr, TH1F* histSig) {
+      if (!hist || !Push(methodName, kPDEFoam, hist)) return kFALSE;
+      fEvaluators.back().hist2 = histErr;
+      fEvaluators.back().hist3 = histSig;
+      return kTRUE;
+   }
+
+   // Signal probability and rarity of the response
+   Bool_t AddProba(const char* methodName, TH1F* histProba, TH1F* histRarity) {
+      if (!histProba || !Push(methodName, kProba, histProba)) return kFALSE;
+      fEvaluators.back().hist2 = histRarity;
+      return kTRUE;
+   }
+
+   void Evaluate() {
+      for (Evaluator& e : fEvaluators) {
+         switch (e.kind) {
+         case kHist:
+            e.hist->Fill( fReader->EvaluateMVA( e.method ) );
+            break;
+         case kCuts:
+            if (fReader->EvaluateMVA( e.method, e.aux )) e.nPassed++;
+            break;
+         case kBDTVsMass: {
+            Double_t val = fReader->EvaluateMVA( e.method );
+            if (*e.origin == 4) { if (e.hist) e.hist->Fill( val ); }
+            else if (*e.origin == 5) { if (e.hist2) e.hist2->Fill( val ); }
+            e.hist2D->Fill( val, *e.mass );
+            break;
+         }
+         case kPDEFoam: {
+            Double_t val = fReader->EvaluateMVA( e.method );
+            Double_t err = fReader->GetMVAError();
+            e.hist->Fill( val );
+            e.hist2->Fill( err );
+            if (err>1.e-50) e.hist3->Fill( val/err );
+            break;
+         }
+         case kProba: {
+            Double_t val = fReader->EvaluateMVA( e.method );
+            e.hist->Fill( e.method->GetProba( val, 0.5 ) );
+            e.hist2->Fill( e.method->GetRarity( val ) );
+            break;
+         }
+         }
+      }
+   }
+
+   Int_t GetN() const { return fEvaluators.size(); }
+   const Evaluator& GetEvaluator(Int_t i) const { return fEvaluators[i]; }
+
+   Long64_t GetNPassed(const char* methodName) const {
+      for (const Evaluator& e : fEvaluators)
+         if (e.kind == kCuts && e.name == methodName) return e.nPassed;
+      return 0;
+   }
+
+   void Print() const {
+      std::cout << "--- Evaluation plan: " << fEvaluators.size() << " evaluator(s)";
+      for (const Evaluator& e : fEvaluators) std::cout << " \"" << e.name << "\"";
+      std::cout << std::endl;
+   }
+
+private:
+   TMVA::Reader* fReader;
+   std::vector<Evaluator> fEvaluators;
+
+   Bool_t Push(const char* methodName, EKind kind, TH1F* hist) {
+      TMVA::MethodBase* method = dynamic_cast<TMVA::MethodBase*>( fReader->FindMVA( methodName ) );
+      if (!method) {
+         std::cout << "--- Evaluation plan: method \"" << methodName << "\" is not booked, skipped" << std::endl;
+         return kFALSE;
+      }
+      Evaluator e = { methodName, method, kind, hist, 0, 0, 0, 0, 0, 0., 0 };
+      fEvaluators.push_back(e);
+      return kTRUE;
+   }
+};
+
+#endif
@@ -3,6 +3,7 @@
 #for i in $(seq 2 7)
 #do
 root.exe -b -l <<EOF
+.L CountHist2D.cpp+
 .L TMVAClassificationApplication.C++
 .> TMVAApp_output_0_1_11.txt
 TMVAClassificationApplication(0,1,"BDT")
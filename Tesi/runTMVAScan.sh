@@ -0,0 +1,9 @@
+#! /bin/bash
+
+root.exe -b -l -lTMVA<<EOF
+.L TMVAClassification.C++
+.> TMVAScan_output_0_1.txt
+TMVAScan(0,1,"NTrees=400,850,1200;MaxDepth=2,3,4;AdaBoostBeta=0.3,0.5;nCuts=20,40",0,8)
+.>
+.q
+EOF